@@ -1,498 +1,1560 @@
-/* Tcl in ~ 500 lines of code.
- *
- * Copyright (c) 2007-2016, Salvatore Sanfilippo <antirez at gmail dot com>
- *                    2022, Tristan Styles
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions are met:
- *
- *   * Redistributions of source code must retain the above copyright notice,
- *     this list of conditions and the following disclaimer.
- *   * Redistributions in binary form must reproduce the above copyright
- *     notice, this list of conditions and the following disclaimer in the
- *     documentation and/or other materials provided with the distribution.
- *
- * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
- * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
- * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
- * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
- * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
- * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
- * POSSIBILITY OF SUCH DAMAGE.
- */
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdarg.h>
-#include <string.h>
-#include <ctype.h>
-
-enum {PICOL_OK, PICOL_ERR, PICOL_RETURN, PICOL_BREAK, PICOL_CONTINUE};
-enum {PT_ESC,PT_STR,PT_CMD,PT_VAR,PT_SEP,PT_EOL,PT_EOF};
-
-struct picolParser {
-	char *text, *pos, *start, *end;
-	int len, type, insidequote;
-};
-
-struct picolVar {
-	char *name, *val;
-	struct picolVar *next;
-};
-
-struct picolInterp {
-	int level; /* Level of nesting */
-	struct picolCallFrame *callframe;
-	struct picolCmd *commands;
-	char *result;
-};
-
-typedef int (*picolCmdFunc)(struct picolInterp *i, int argc, char **argv, void *privdata);
-
-struct picolCmd {
-	char *name;
-	picolCmdFunc func;
-	void *privdata;
-	struct picolCmd *next;
-};
-
-struct picolCallFrame {
-	struct picolVar *vars;
-	struct picolCallFrame *parent; /* parent is NULL at top level */
-};
-
-static char *picolGets(FILE *in, int end) {
-	char *buf = malloc(1);
-	for (int n=0, z=0, c; (buf[n]='\0') || (c=fgetc(in))!=end; buf[n++]=c)
-		if (n==z) buf = realloc(buf,(z=(z+1)+(z>>1))+1);
-	return buf;
-}
-
-static void picolSetResult(struct picolInterp *i, char *s) {
-	free(i->result);
-	i->result = strdup(s);
-}
-
-static int picolErr(struct picolInterp *i, char const *f, ...) {
-	va_list v1, v2; va_start(v1,f), va_copy(v2,v1);
-	size_t n = vsnprintf(NULL,0,f,v1);
-	free(i->result);
-	i->result = malloc(n+1);
-	vsnprintf(i->result,n+1,f,v2);
-	va_end(v2), va_end(v1);
-	return PICOL_ERR;
-}
-
-static void picolInitParser(struct picolParser *p, char *text) {
-	p->text = p->pos = p->start = p->end = text;
-	p->len = strlen(text);
-	p->insidequote = 0;
-	p->type = PT_EOL;
-}
-
-static int picolParseSep(struct picolParser *p, int eol) {
-	for (p->start = p->pos; !isgraph(*p->pos) || (eol && *p->pos == eol); p->pos++, p->len--);
-	p->end = p->pos-1;
-	p->type = eol ? PT_EOL : PT_SEP;
-	return PICOL_OK;
-}
-
-static int picolParseCommand(struct picolParser *p) {
-	p->start = ++p->pos; p->len--; /* skip the initial opening bracket */
-	for (int level = 1, blevel = 0; p->len > 0; p->pos++, p->len--)
-		if (*p->pos == '\\') {
-			if (p->len > 1) p->pos++, p->len--;
-		} else if (*p->pos == '[') {
-			if (blevel == 0) level++;
-		} else if (*p->pos == ']') {
-			if (blevel == 0 && !--level) break;
-		} else if (*p->pos == '{') {
-			blevel++;
-		} else if (*p->pos == '}') {
-			if (blevel != 0) blevel--;
-		}
-	p->end = p->pos-1;
-	p->type = PT_CMD;
-	if (*p->pos == ']') p->pos++, p->len--; /* Skip final closed bracket */
-	return PICOL_OK;
-}
-
-static int picolParseVar(struct picolParser *p) {
-	p->start = ++p->pos; p->len--; /* skip the $ */
-	for(; isalnum(*p->pos) || *p->pos == '_'; p->pos++, p->len--);
-	if (p->start == p->pos) { /* It's just a single char string "$" */
-		p->start = p->end = p->pos-1;
-		p->type = PT_STR;
-	} else {
-		p->end = p->pos-1;
-		p->type = PT_VAR;
-	}
-	return PICOL_OK;
-}
-
-static int picolParseBrace(struct picolParser *p) {
-	p->start = ++p->pos; p->len--; /* skip the initial opening brace */
-	for (int level = 1; p->len > 0; p->pos++, p->len--)
-		if (*p->pos == '{') level++;
-		else if (p->len >= 2 && *p->pos == '\\') p->pos++, p->len--;
-		else if (*p->pos == '}' && !--level) break;
-	p->end = p->pos-1;
-	if (p->len > 0) p->pos++, p->len--; /* Skip final closed brace */
-	p->type = PT_STR;
-	return PICOL_OK;
-}
-
-static int picolParseString(struct picolParser *p) {
-	int newword = (p->type == PT_SEP || p->type == PT_EOL || p->type == PT_STR);
-	if (newword && *p->pos == '{') return picolParseBrace(p);
-	if (newword && *p->pos == '"') {
-		p->insidequote = 1;
-		p->pos++, p->len--;
-	}
-	for (p->start = p->pos; p->len > 0; p->pos++, p->len--)
-		switch (*p->pos) {
-		default:
-			if ((!isgraph(*p->pos) || *p->pos == ';') && !p->insidequote) {
-		case '$': case '[':
-				goto end;
-			}
-			break;
-		case '"':
-			if (!p->insidequote) break;
-			p->end = p->pos-1;
-			p->type = PT_ESC;
-			p->pos++, p->len--;
-			p->insidequote = 0;
-			return PICOL_OK;
-		case '\\':
-			if (p->len >= 2) p->pos++, p->len--;
-		}
-end:
-	p->end = p->pos-1;
-	p->type = PT_ESC;
-	return PICOL_OK;
-}
-
-static int picolParseComment(struct picolParser *p) {
-	for(; p->len && *p->pos != '\n'; p->pos++, p->len--);
-	return PICOL_OK;
-}
-
-static int picolGetToken(struct picolParser *p) {
-	while (p->len > 0)
-		switch (*p->pos) {
-		default:
-			if (isgraph(*p->pos) || p->insidequote) return picolParseString(p);
-			return picolParseSep(p, 0);
-		case '\n': case ';':
-			if (p->insidequote) return picolParseString(p);
-			return picolParseSep(p, ';');
-		case '[': return picolParseCommand(p);
-		case '$': return picolParseVar(p);
-		case '#':
-			if (p->type != PT_EOL) return picolParseString(p);
-			picolParseComment(p);
-		}
-	p->type = (p->type != PT_EOL && p->type != PT_EOF) ? PT_EOL : PT_EOF;
-	return PICOL_OK;
-}
-
-static void picolInitInterp(struct picolInterp *i) {
-	i->level = 0;
-	i->callframe = malloc(sizeof(struct picolCallFrame));
-	i->callframe->vars = NULL;
-	i->callframe->parent = NULL;
-	i->commands = NULL;
-	i->result = strdup("");
-}
-
-static struct picolVar *picolGetVar(struct picolInterp *i, char *name) {
-	for (struct picolVar *v = i->callframe->vars; v != NULL; v = v->next)
-		if (strcmp(v->name,name) == 0) return v;
-	return NULL;
-}
-
-static int picolSetVar(struct picolInterp *i, char *name, char *val) {
-	struct picolVar *v = picolGetVar(i,name);
-	if (v) free(v->val);
-	else {
-		v = malloc(sizeof(*v));
-		v->name = strdup(name);
-		v->next = i->callframe->vars;
-		i->callframe->vars = v;
-	}
-	v->val = strdup(val);
-	return PICOL_OK;
-}
-
-static struct picolCmd *picolGetCommand(struct picolInterp *i, char *name) {
-	for (struct picolCmd *c = i->commands; c != NULL; c = c->next)
-		if (strcmp(c->name,name) == 0) return c;
-	return NULL;
-}
-
-static int picolRegisterCommand(struct picolInterp *i, char *name, picolCmdFunc f, void *privdata) {
-	struct picolCmd *c = picolGetCommand(i,name);
-	if (c) return picolErr(i,"Command '%s' already defined",name);
-	c = malloc(sizeof(*c));
-	c->name = strdup(name);
-	c->func = f;
-	c->privdata = privdata;
-	c->next = i->commands;
-	i->commands = c;
-	return PICOL_OK;
-}
-
-static int toxdigit(int c) { return isalpha(c) ? (10+(toupper(c)-'A')) : (c-'0'); }
-
-static int picolEscape(char *b, int n) {
-	char *s = strchr(b, '\\');
-	if (s) for (char *t = s; *s; ) {
-		if (*s == '\\')
-			switch (*(s+1)) {
-			default :
-				s++, n--;
-				if (isgraph(*s)) break;
-				for (s++, n--; n > 0 && !isgraph(*s); s++, n--);
-				continue;
-			case 'X': case 'x':
-				s+=2, n-=2;
-				if (isxdigit(*s) && isxdigit(*(s+1))) {
-					*t++ = (toxdigit(*s) << 4) | toxdigit(*(s+1));
-					s+=2, n-=2;
-				} else if (isxdigit(*s)) {
-					*t++ = toxdigit(isalpha(*s));
-					s++, n--;
-				}
-				continue;
-			case 'n': s+=2, n--, *t++ = '\n'; continue;
-			case 'r': s+=2, n--, *t++ = '\r'; continue;
-			case 't': s+=2, n--, *t++ = '\t'; continue;
-			case'\0': s++, n--; continue;
-			}
-		*t++ = *s++;
-	}
-	b[n] = '\0';
-	return n;
-}
-
-static int picolEval(struct picolInterp *i, char *s) {
-	struct picolParser p;
-	int retcode = PICOL_OK, argc = 0, j;
-	char **argv = NULL;
-	picolSetResult(i,"");
-	picolInitParser(&p,s);
-	for (int prevtype = p.type; picolGetToken(&p) == PICOL_OK; prevtype = p.type) {
-		if (p.type == PT_EOF) break;
-		int tlen = p.end-p.start+1;
-		if (tlen < 0) tlen = 0;
-		char *t = memcpy(malloc(tlen+1), p.start, tlen);
-		t[tlen] = '\0';
-		if (p.type == PT_VAR) {
-			struct picolVar *v = picolGetVar(i,t);
-			if (!v) {
-				retcode = picolErr(i,"No such variable '%s'",t);
-				free(t);
-				break;
-			}
-			free(t);
-			t = strdup(v->val);
-			tlen = strlen(t);
-		} else if (p.type == PT_CMD) {
-			retcode = picolEval(i,t);
-			free(t);
-			if (retcode != PICOL_OK) break;
-			t = strdup(i->result);
-			tlen = strlen(t);
-		} else if (p.type == PT_ESC) {
-			tlen = picolEscape(t, tlen);
-		} else if (p.type == PT_SEP) {
-			free(t);
-			continue;
-		} else if (p.type == PT_EOL) {
-			struct picolCmd *c;
-			free(t);
-			if (argc) { /* We have a complete command + args. Call it! */
-				if ((c = picolGetCommand(i,argv[0])) == NULL) {
-					retcode = picolErr(i,"No such command '%s'",argv[0]);
-					break;
-				}
-				retcode = c->func(i,argc,argv,c->privdata);
-				if (retcode != PICOL_OK) break;
-			}
-			/* Prepare for the next command */
-			for (j = 0; j < argc; j++) free(argv[j]);
-			free(argv);
-			argv = NULL;
-			argc = 0;
-			continue;
-		}
-		/* We have a new token, append to the previous or as new arg? */
-		if (prevtype == PT_SEP || prevtype == PT_EOL) {
-			argv = realloc(argv, sizeof(char*)*(argc+1));
-			argv[argc] = t;
-			argc++;
-		} else { /* Interpolation */
-			int oldlen = strlen(argv[argc-1]);
-			argv[argc-1] = realloc(argv[argc-1], oldlen+tlen+1);
-			memcpy(argv[argc-1]+oldlen, t, tlen);
-			argv[argc-1][oldlen+tlen]='\0';
-			free(t);
-		}
-	}
-	for (j = 0; j < argc; j++) free(argv[j]);
-	free(argv);
-	return retcode;
-}
-
-static int picolArityErr(struct picolInterp *i, char *name) {
-	return picolErr(i,"Wrong number of args for %s",name);
-}
-
-static int picolCommandMath(struct picolInterp *i, int argc, char **argv, void *pd) {
-	char buf[(sizeof(int)*CHAR_BIT)/3];
-	if (argc != 3) return picolArityErr(i,argv[0]);
-	int o = argv[0][0]^argv[0][1]<<8, a = atoi(argv[1]), b = atoi(argv[2]), c = 0;
-	/**/ if (o ==  '+') c = a + b;
-	else if (o ==  '-') c = a - b;
-	else if (o ==  '*') c = a * b;
-	else if (o ==  '/') c = a / b;
-	else if (o ==  '>') c = a > b;
-	else if (o == ('>'^'='<<8)) c = a >= b;
-	else if (o ==  '<') c = a < b;
-	else if (o == ('<'^'='<<8)) c = a <= b;
-	else if (o == ('='^'='<<8)) c = a == b;
-	else if (o == ('!'^'='<<8)) c = a != b;
-	snprintf(buf,sizeof(buf),"%d",c);
-	picolSetResult(i,buf);
-	return PICOL_OK;
-}
-
-static int picolCommandSet(struct picolInterp *i, int argc, char **argv, void *pd) {
-	if (argc != 3) return picolArityErr(i,argv[0]);
-	picolSetVar(i,argv[1],argv[2]);
-	picolSetResult(i,argv[2]);
-	return PICOL_OK;
-}
-
-static int picolCommandPuts(struct picolInterp *i, int argc, char **argv, void *pd) {
-    if (argc != 2) return picolArityErr(i,argv[0]);
-    puts(argv[1]);
-	return PICOL_OK;
-}
-
-static int picolCommandIf(struct picolInterp *i, int argc, char **argv, void *pd) {
-	if (argc != 3 && argc != 5) return picolArityErr(i,argv[0]);
-	for (int retcode = picolEval(i,argv[1]); retcode != PICOL_OK; ) return retcode;
-	if (atoi(i->result)) return picolEval(i,argv[2]);
-	if (argc == 5) return picolEval(i,argv[4]);
-	return PICOL_OK;
-}
-
-static int picolCommandWhile(struct picolInterp *i, int argc, char **argv, void *pd) {
-	for (int retcode; argc == 3; )
-		if ((retcode = picolEval(i,argv[1])) != PICOL_OK) return retcode;
-		else if (atoi(i->result) == 0) return PICOL_OK;
-		else if ((retcode = picolEval(i,argv[2])) == PICOL_CONTINUE) continue;
-		else if (retcode == PICOL_OK) continue;
-		else if (retcode != PICOL_BREAK) return retcode;
-	return picolArityErr(i,argv[0]);
-}
-
-static int picolCommandRetCodes(struct picolInterp *i, int argc, char **argv, void *pd) {
-	if (argc != 1) return picolArityErr(i,argv[0]);
-	if (strcmp(argv[0],"break") == 0) return PICOL_BREAK;
-	if (strcmp(argv[0],"continue") == 0) return PICOL_CONTINUE;
-	return PICOL_OK;
-}
-
-static void picolDropCallFrame(struct picolInterp *i) {
-	struct picolCallFrame *cf = i->callframe;
-	for (struct picolVar *v = cf->vars, *t; v != NULL; v = t) {
-		t = v->next;
-		free(v->name);
-		free(v->val);
-		free(v);
-	}
-	i->callframe = cf->parent;
-	free(cf);
-}
-
-static int picolCommandCallProc(struct picolInterp *i, int argc, char **argv, void *pd) {
-	char **x=pd, *alist=x[0], *body=x[1], *tofree=strdup(alist);
-	struct picolCallFrame *cf = malloc(sizeof(*cf));
-	int arity = 0, done = 0, errcode = PICOL_OK;
-	cf->vars = NULL;
-	cf->parent = i->callframe;
-	i->callframe = cf;
-	for (char *s = tofree, *start; !done; s++) {
-		for (start = s; *s != ' ' && *s != '\0'; s++);
-		if (*s != '\0' && s == start) continue;
-		if (s == start) break;
-		if (*s == '\0') done=1; else *s = '\0';
-		if (++arity > argc-1) goto arityerr;
-		picolSetVar(i,start,argv[arity]);
-	}
-	free(tofree);
-	if (arity != argc-1) goto arityerr;
-	errcode = picolEval(i,body);
-	if (errcode == PICOL_RETURN) errcode = PICOL_OK;
-	picolDropCallFrame(i); /* remove the called proc callframe */
-	return errcode;
-arityerr:
-	picolDropCallFrame(i); /* remove the called proc callframe */
-	return picolErr(i,"Proc '%s' called with wrong arg num",argv[0]);
-}
-
-static int picolCommandProc(struct picolInterp *i, int argc, char **argv, void *pd) {
-	if (argc != 4) return picolArityErr(i,argv[0]);
-	char **procdata = malloc(sizeof(char*)*2);
-	procdata[0] = strdup(argv[2]); /* arguments list */
-	procdata[1] = strdup(argv[3]); /* procedure body */
-	return picolRegisterCommand(i,argv[1],picolCommandCallProc,procdata);
-}
-
-static int picolCommandReturn(struct picolInterp *i, int argc, char **argv, void *pd) {
-	if (argc != 1 && argc != 2) return picolArityErr(i,argv[0]);
-	picolSetResult(i, (argc == 2) ? argv[1] : "");
-	return PICOL_RETURN;
-}
-
-static void picolRegisterCoreCommands(struct picolInterp *i) {
-	char *name[] = {"+","-","*","/",">",">=","<","<=","==","!="};
-	for (int j = 0; j < (int)(sizeof(name)/sizeof(char*)); j++)
-		picolRegisterCommand(i,name[j],picolCommandMath,NULL);
-	picolRegisterCommand(i,"set",picolCommandSet,NULL);
-	picolRegisterCommand(i,"puts",picolCommandPuts,NULL);
-	picolRegisterCommand(i,"if",picolCommandIf,NULL);
-	picolRegisterCommand(i,"while",picolCommandWhile,NULL);
-	picolRegisterCommand(i,"break",picolCommandRetCodes,NULL);
-	picolRegisterCommand(i,"continue",picolCommandRetCodes,NULL);
-	picolRegisterCommand(i,"proc",picolCommandProc,NULL);
-	picolRegisterCommand(i,"return",picolCommandReturn,NULL);
-}
-
-int main(int argc, char **argv) {
-	char *buf;
-	struct picolInterp interp;
-	picolInitInterp(&interp);
-	picolRegisterCoreCommands(&interp);
-	for (int retcode; argc == 1; free(buf)) {
-		printf("picol> "), fflush(stdout);
-		buf = picolGets(stdin,'\n');
-		if (strcmp(buf,"quit") == 0) return EXIT_SUCCESS;
-		retcode = picolEval(&interp,buf);
-		if (interp.result[0] != '\0') printf("[%d] %s\n", retcode, interp.result);
-	}
-	for (FILE *fp; (argc>1) && (fp=fopen(argv[1],"r")); free(buf), argc--, argv++) {
-		buf = picolGets(fp,EOF), fclose(fp);
-		if (picolEval(&interp,buf) != PICOL_OK) puts(interp.result);
-	}
-	if (argc < 2) return EXIT_SUCCESS;
-	perror(argv[1]);
-	return EXIT_FAILURE;
-}
+/* Tcl in ~ 500 lines of code.
+ *
+ * Copyright (c) 2007-2016, Salvatore Sanfilippo <antirez at gmail dot com>
+ *                    2022, Tristan Styles
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+enum {PICOL_OK, PICOL_ERR, PICOL_RETURN, PICOL_BREAK, PICOL_CONTINUE, PICOL_LIMIT};
+enum {PT_ESC,PT_STR,PT_CMD,PT_VAR,PT_SEP,PT_EOL,PT_EOF};
+enum {PS_ASCII,PS_DICTIONARY,PS_INTEGER,PS_REAL,PS_COMMAND};
+enum {RE_CHAR,RE_ANY,RE_CLASS,RE_SPLIT,RE_JMP,RE_SAVE,RE_BOL,RE_EOL,RE_MATCH};
+enum {PICOL_CMDHASH = 128, PICOL_ARRHASH = 16}; /* command table and array buckets, powers of two */
+enum {PICOL_TICKS = 1024}; /* commands dispatched between limit checks */
+enum {PICOL_RECACHE = 32}; /* compiled regexps kept per interp */
+enum {PICOL_REMAX = 1 << 20}; /* regexp instructions times capture slots, bounds compile and match memory */
+enum {PICOL_SPAREFRAMES = 8}; /* call frames kept for reuse per interp */
+
+struct picolParser {
+	char *text, *pos, *start, *end;
+	int len, type, insidequote;
+};
+
+struct picolVar {
+	char *val;
+	struct picolVar *next, **elems; /* elems are the PICOL_ARRHASH buckets of an array */
+	char name[]; /* allocated along with the node */
+};
+
+struct picolInterp {
+	int level, nspare; /* Level of nesting, frames on the spare list */
+	struct picolCallFrame *callframe, *spareframes; /* spare frames are recycled by proc calls */
+	struct picolCmd *commands[PICOL_CMDHASH];
+	char *result;
+	unsigned long cmdcount, checkat, cmdlimit; /* commands run, when to check limits next, limit (0 = none) */
+	clock_t deadline; /* processor time limit (0 = none) */
+	struct picolRegex *regexps; /* compiled, most recently used first */
+};
+
+typedef int (*picolCmdFunc)(struct picolInterp *i, int argc, char **argv, void *privdata);
+
+struct picolCmd {
+	picolCmdFunc func;
+	void *privdata;
+	struct picolCmd *next;
+	char name[]; /* allocated along with the node */
+};
+
+struct picolProc { /* one block: this header, args[arity], the split arg list, the body */
+	char **args, *body;
+	int arity;
+};
+
+struct picolSortItem {
+	char *s;
+	long ikey; /* parsed once for -integer */
+	double key; /* parsed once for -real */
+};
+
+struct picolSort {
+	struct picolInterp *i;
+	int mode, order, retcode;
+	char *cmd;
+};
+
+struct picolReInst {
+	int op, x, y; /* RE_CHAR char, RE_SAVE slot, or jumps relative to this instruction */
+	unsigned char set[32]; /* RE_CLASS members */
+};
+
+struct picolRegex {
+	char *pattern;
+	int nocase, n, nsub; /* n instructions, nsub capture groups */
+	struct picolReInst *code;
+	struct picolRegex *next;
+};
+
+struct picolCallFrame {
+	struct picolVar *vars;
+	struct picolCallFrame *parent; /* parent is NULL at top level */
+};
+
+/* ASCII classes, independent of the locale (and of the sign of char) */
+static int picolIsGraph(int c) { return (unsigned char)c-0x21u < 0x5eu; }
+static int picolIsAlnum(int c) { return (unsigned)(unsigned char)c-'0' < 10u || (unsigned)((unsigned char)c|0x20)-'a' < 26u; }
+static int picolIsDigit(int c) { return (unsigned)(unsigned char)c-'0' < 10u; }
+static int picolIsXDigit(int c) { return (unsigned)(unsigned char)c-'0' < 10u || (unsigned)((unsigned char)c|0x20)-'a' < 6u; }
+
+static char *picolGets(FILE *in, int end) { /* NULL at end of input, unless reading to EOF */
+	char *buf = malloc(1);
+	int n=0, z=0, c;
+	for (; (buf[n]='\0') || ((c=fgetc(in))!=end && c!=EOF); buf[n++]=c)
+		if (n==z) buf = realloc(buf,(z=(z+1)+(z>>1))+1);
+	if (c == EOF && n == 0 && end != EOF) return free(buf), NULL;
+	return buf;
+}
+
+static char *picolLoad(FILE *in) { /* whole file in one read, unless unseekable */
+	long n;
+	if (fseek(in,0,SEEK_END) || (n=ftell(in)) < 0 || n == LONG_MAX || fseek(in,0,SEEK_SET)) return picolGets(in,EOF); /* directories report LONG_MAX */
+	char *buf = malloc(n+1);
+	if (buf == NULL) return picolGets(in,EOF);
+	buf[fread(buf,1,n,in)] = '\0';
+	return buf;
+}
+
+static void picolSetResult(struct picolInterp *i, char *s) {
+	free(i->result);
+	i->result = strdup(s);
+}
+
+static void picolSetResultLen(struct picolInterp *i, char const *s, size_t n) { /* s need not be terminated */
+	free(i->result);
+	i->result = memcpy(malloc(n+1),s,n);
+	i->result[n] = '\0';
+}
+
+static char *picolMoveResult(struct picolInterp *i) { /* hand the result over, no copy */
+	char *s = i->result;
+	i->result = strdup("");
+	return s;
+}
+
+static void picolSetIntResult(struct picolInterp *i, int n) {
+	char buf[(sizeof(int)*CHAR_BIT)/3+3], *s = buf+sizeof(buf);
+	unsigned u = (n < 0) ? -(unsigned)n : (unsigned)n;
+	*--s = '\0';
+	do *--s = '0'+u%10; while (u /= 10);
+	if (n < 0) *--s = '-';
+	picolSetResult(i,s);
+}
+
+static int picolToInt(char const *s) { /* plain decimals inline, anything else via atoi */
+	char const *d = s+(*s == '-'), *t = d;
+	unsigned u = 0;
+	for (; *t >= '0' && *t <= '9'; t++) u = u*10+(*t-'0');
+	if (*t || t == d || t-d > 9) return atoi(s);
+	return (d != s) ? -(int)u : (int)u;
+}
+
+static int picolErr(struct picolInterp *i, char const *f, ...) {
+	va_list v1, v2; va_start(v1,f), va_copy(v2,v1);
+	size_t n = vsnprintf(NULL,0,f,v1);
+	free(i->result);
+	i->result = malloc(n+1);
+	vsnprintf(i->result,n+1,f,v2);
+	va_end(v2), va_end(v1);
+	return PICOL_ERR;
+}
+
+static int picolCheckLimits(struct picolInterp *i) { /* limits are one-shot: tripping one clears it */
+	if (i->cmdlimit && i->cmdcount > i->cmdlimit)
+		return i->cmdlimit = 0, picolErr(i,"Command limit exceeded"), PICOL_LIMIT;
+	if (i->deadline && clock() >= i->deadline)
+		return i->deadline = 0, picolErr(i,"Time limit exceeded"), PICOL_LIMIT;
+	i->checkat = i->cmdcount+PICOL_TICKS;
+	if (i->cmdlimit && i->checkat > i->cmdlimit) i->checkat = i->cmdlimit+1;
+	return PICOL_OK;
+}
+
+static void picolInitParser(struct picolParser *p, char *text) {
+	p->text = p->pos = p->start = p->end = text;
+	p->len = strlen(text);
+	p->insidequote = 0;
+	p->type = PT_EOL;
+}
+
+static int picolParseSep(struct picolParser *p, int eol) {
+	for (p->start = p->pos; p->len > 0 && (!picolIsGraph(*p->pos) || (eol && *p->pos == eol)); p->pos++, p->len--);
+	p->end = p->pos-1;
+	p->type = eol ? PT_EOL : PT_SEP;
+	return PICOL_OK;
+}
+
+static int picolParseCommand(struct picolParser *p) {
+	p->start = ++p->pos; p->len--; /* skip the initial opening bracket */
+	for (int level = 1, blevel = 0; p->len > 0; p->pos++, p->len--)
+		if (*p->pos == '\\') {
+			if (p->len > 1) p->pos++, p->len--;
+		} else if (*p->pos == '[') {
+			if (blevel == 0) level++;
+		} else if (*p->pos == ']') {
+			if (blevel == 0 && !--level) break;
+		} else if (*p->pos == '{') {
+			blevel++;
+		} else if (*p->pos == '}') {
+			if (blevel != 0) blevel--;
+		}
+	p->end = p->pos-1;
+	p->type = PT_CMD;
+	if (*p->pos == ']') p->pos++, p->len--; /* Skip final closed bracket */
+	return PICOL_OK;
+}
+
+static int picolParseVar(struct picolParser *p) {
+	p->start = ++p->pos; p->len--; /* skip the $ */
+	for(; picolIsAlnum(*p->pos) || *p->pos == '_'; p->pos++, p->len--);
+	if (p->start != p->pos && p->len > 0 && *p->pos == '(') { /* array element, up to the closing paren */
+		int k = 1;
+		while (k < p->len && p->pos[k] != ')') k++;
+		if (k < p->len) p->pos += k+1, p->len -= k+1;
+	}
+	if (p->start == p->pos) { /* It's just a single char string "$" */
+		p->start = p->end = p->pos-1;
+		p->type = PT_STR;
+	} else {
+		p->end = p->pos-1;
+		p->type = PT_VAR;
+	}
+	return PICOL_OK;
+}
+
+static int picolParseBrace(struct picolParser *p) {
+	p->start = ++p->pos; p->len--; /* skip the initial opening brace */
+	for (int level = 1; p->len > 0; p->pos++, p->len--)
+		if (*p->pos == '{') level++;
+		else if (p->len >= 2 && *p->pos == '\\') p->pos++, p->len--;
+		else if (*p->pos == '}' && !--level) break;
+	p->end = p->pos-1;
+	if (p->len > 0) p->pos++, p->len--; /* Skip final closed brace */
+	p->type = PT_STR;
+	return PICOL_OK;
+}
+
+static int picolParseString(struct picolParser *p) {
+	int newword = (p->type == PT_SEP || p->type == PT_EOL || p->type == PT_STR);
+	if (newword && *p->pos == '{') return picolParseBrace(p);
+	if (newword && *p->pos == '"') {
+		p->insidequote = 1;
+		p->pos++, p->len--;
+	}
+	for (p->start = p->pos; p->len > 0; p->pos++, p->len--)
+		switch (*p->pos) {
+		default:
+			if ((!picolIsGraph(*p->pos) || *p->pos == ';') && !p->insidequote) {
+		case '$': case '[':
+				goto end;
+			}
+			break;
+		case '"':
+			if (!p->insidequote) break;
+			p->end = p->pos-1;
+			p->type = PT_ESC;
+			p->pos++, p->len--;
+			p->insidequote = 0;
+			return PICOL_OK;
+		case '\\':
+			if (p->len >= 2) p->pos++, p->len--;
+		}
+end:
+	p->end = p->pos-1;
+	p->type = PT_ESC;
+	return PICOL_OK;
+}
+
+static int picolParseComment(struct picolParser *p) {
+	for(; p->len && *p->pos != '\n'; p->pos++, p->len--);
+	return PICOL_OK;
+}
+
+static int picolGetToken(struct picolParser *p) {
+	while (p->len > 0)
+		switch (*p->pos) {
+		default:
+			if (picolIsGraph(*p->pos) || p->insidequote) return picolParseString(p);
+			return picolParseSep(p, 0);
+		case '\n': case ';':
+			if (p->insidequote) return picolParseString(p);
+			return picolParseSep(p, ';');
+		case '[': return picolParseCommand(p);
+		case '$': return picolParseVar(p);
+		case '#':
+			if (p->type != PT_EOL) return picolParseString(p);
+			picolParseComment(p);
+		}
+	p->type = (p->type != PT_EOL && p->type != PT_EOF) ? PT_EOL : PT_EOF;
+	return PICOL_OK;
+}
+
+static void picolInitInterp(struct picolInterp *i) {
+	i->level = 0;
+	i->callframe = malloc(sizeof(struct picolCallFrame));
+	i->callframe->vars = NULL;
+	i->callframe->parent = NULL;
+	i->spareframes = NULL;
+	i->nspare = 0;
+	for (int j = 0; j < PICOL_CMDHASH; j++) i->commands[j] = NULL;
+	i->result = strdup("");
+	i->cmdcount = i->cmdlimit = i->deadline = 0;
+	i->checkat = PICOL_TICKS;
+	i->regexps = NULL;
+}
+
+static unsigned picolHash(char const *s, size_t n) {
+	unsigned h = 5381;
+	while (n--) h = (h*33)^(unsigned char)*s++;
+	return h;
+}
+
+static size_t picolArrayName(char const *name, size_t *n) { /* length of the array part of name(key), or 0 */
+	char const *paren = strchr(name,'(');
+	*n = strlen(name);
+	return (paren && paren != name && name[*n-1] == ')') ? (size_t)(paren-name) : 0;
+}
+
+static struct picolVar *picolFindVar(struct picolVar *v, char const *name, size_t n) {
+	for (; v != NULL; v = v->next)
+		if (strncmp(v->name,name,n) == 0 && v->name[n] == '\0') return v;
+	return NULL;
+}
+
+static struct picolVar *picolNewVar(struct picolVar **list, char const *name, size_t n, char const *val) {
+	struct picolVar *v = malloc(sizeof(*v)+n+1);
+	memcpy(v->name,name,n), v->name[n] = '\0';
+	v->val = strdup(val);
+	v->elems = NULL;
+	v->next = *list;
+	return *list = v;
+}
+
+static struct picolVar **picolElemBucket(struct picolVar *a, char const *key, size_t k) {
+	return &a->elems[picolHash(key,k) & (PICOL_ARRHASH-1)];
+}
+
+static struct picolVar *picolGetElem(struct picolInterp *i, char const *name, size_t n, char const *key, size_t k) {
+	struct picolVar *a = picolFindVar(i->callframe->vars,name,n);
+	return (a && a->elems) ? picolFindVar(*picolElemBucket(a,key,k),key,k) : NULL;
+}
+
+static struct picolVar *picolGetVar(struct picolInterp *i, char *name) { /* name or name(key) */
+	size_t n, an = picolArrayName(name,&n);
+	if (an) return picolGetElem(i,name,an,name+an+1,n-an-2);
+	return picolFindVar(i->callframe->vars,name,n);
+}
+
+static void picolSetVal(struct picolVar *v, char *val) { /* reuse the old buffer when it fits, and is not far too big */
+	size_t n = strlen(val), z = strlen(v->val);
+	if (z >= n && z <= 2*n+16) memcpy(v->val,val,n+1);
+	else free(v->val), v->val = strdup(val);
+}
+
+static int picolSetElem(struct picolInterp *i, char const *name, size_t n, char const *key, size_t k, char *val) {
+	struct picolVar *a = picolFindVar(i->callframe->vars,name,n), *v;
+	if (!a) a = picolNewVar(&i->callframe->vars,name,n,""), a->elems = calloc(PICOL_ARRHASH,sizeof(*a->elems));
+	else if (!a->elems) return picolErr(i,"Can't set '%.*s(%.*s)': variable isn't array",(int)n,name,(int)k,key);
+	if ((v = picolFindVar(*picolElemBucket(a,key,k),key,k)) != NULL) picolSetVal(v,val);
+	else picolNewVar(picolElemBucket(a,key,k),key,k,val);
+	return PICOL_OK;
+}
+
+static int picolSetVar(struct picolInterp *i, char *name, char *val) { /* name or name(key) */
+	size_t n, an = picolArrayName(name,&n);
+	struct picolVar *v;
+	if (an) return picolSetElem(i,name,an,name+an+1,n-an-2,val);
+	if ((v = picolFindVar(i->callframe->vars,name,n)) == NULL) picolNewVar(&i->callframe->vars,name,n,val);
+	else if (v->elems) return picolErr(i,"Can't set '%s': variable is array",name);
+	else picolSetVal(v,val);
+	return PICOL_OK;
+}
+
+static int picolUpdateVar(struct picolInterp *i, char *name, struct picolVar **v) { /* a scalar to modify in place, created empty if unset */
+	int retcode = PICOL_OK;
+	if ((*v = picolGetVar(i,name)) == NULL) {
+		if ((retcode = picolSetVar(i,name,"")) == PICOL_OK) *v = picolGetVar(i,name);
+	} else if ((*v)->elems) retcode = picolErr(i,"Can't set '%s': variable is array",name);
+	return retcode;
+}
+
+static struct picolCmd **picolCmdBucket(struct picolInterp *i, char const *name) {
+	return &i->commands[picolHash(name,strlen(name)) & (PICOL_CMDHASH-1)];
+}
+
+static struct picolCmd *picolGetCommand(struct picolInterp *i, char *name) {
+	for (struct picolCmd *c = *picolCmdBucket(i,name); c != NULL; c = c->next)
+		if (strcmp(c->name,name) == 0) return c;
+	return NULL;
+}
+
+static int picolRegisterCommand(struct picolInterp *i, char *name, picolCmdFunc f, void *privdata) {
+	struct picolCmd *c = picolGetCommand(i,name);
+	if (c) return picolErr(i,"Command '%s' already defined",name);
+	c = malloc(sizeof(*c)+strlen(name)+1);
+	strcpy(c->name,name);
+	c->func = f;
+	c->privdata = privdata;
+	struct picolCmd **b = picolCmdBucket(i,name);
+	c->next = *b;
+	*b = c;
+	return PICOL_OK;
+}
+
+static void picolFreeList(int argc, char **argv) {
+	for (int j = 0; j < argc; j++) free(argv[j]);
+	free(argv);
+}
+
+static int picolEscape(char *b, int n);
+
+static char **picolSplitList(char const *s, int *argc) { /* words, {braced} or "quoted" elements */
+	char **argv = NULL;
+	for (*argc = 0; *(s += strspn(s," \t\r\n")); (*argc)++) {
+		char const *b = s, *e;
+		int braced = (*s == '{');
+		if (braced) {
+			for (int level = 1; *++s; )
+				if (*s == '\\') { if (!*++s) break; } /* \{ and \} don't nest */
+				else if (!(level += (*s == '{')-(*s == '}'))) break;
+		} else if (*s == '"') for (s++; *s && *s != '"'; s++) s += (*s == '\\' && s[1]);
+		else for (; *s && !strchr(" \t\r\n",*s); s++) s += (*s == '\\' && s[1]);
+		if (e = s, *b == '{' || *b == '"') b++, s += (*s != '\0');
+		argv = realloc(argv, sizeof(char*)*(*argc+1));
+		argv[*argc] = memcpy(malloc(e-b+1), b, e-b);
+		argv[*argc][e-b] = '\0';
+		if (!braced) picolEscape(argv[*argc],e-b); /* backslashes are literal only inside braces */
+	}
+	return argv;
+}
+
+static int picolBraceable(char const *s) { /* braces balance once backslash pairs are skipped */
+	int level = 0;
+	for (; *s && level >= 0; s++)
+		if (*s == '\\') { if (!*++s) return 0; } /* \{ and \} don't nest, as in picolSplitList */
+		else level += (*s == '{')-(*s == '}');
+	return level == 0;
+}
+
+static char *picolListAppend(char *l, size_t *n, char const *s) { /* s as a plain word, braced or backslash-escaped */
+	size_t k = strlen(s);
+	int quote = (k == 0 || s[strcspn(s," \t\r\n{}\"[]$\\;")] != '\0');
+	int brace = quote && picolBraceable(s);
+	char *t = (l = realloc(l, *n+4*k+4))+*n;
+	if (*n) *t++ = ' ';
+	if (brace || !quote) {
+		if (brace) *t++ = '{';
+		t = memcpy(t,s,k), t += k;
+		if (brace) *t++ = '}';
+	} else for (; *s; s++) /* unbalanced braces: escape what the list parser would act on */
+		switch (*s) {
+		case ' ': t = memcpy(t,"\\x20",4), t += 4; break;
+		case '\n': *t++ = '\\', *t++ = 'n'; break;
+		case '\t': *t++ = '\\', *t++ = 't'; break;
+		case '\r': *t++ = '\\', *t++ = 'r'; break;
+		case '{': case '}': case '"': case '[': case ']': case '$': case '\\': case ';': *t++ = '\\'; /* fall through */
+		default: *t++ = *s;
+		}
+	*t = '\0';
+	*n = t-l;
+	return l;
+}
+
+static int picolListIndex(char const *s, int n) { /* an integer, end or end-k */
+	if (strncmp(s,"end",3) == 0) return n-1-((s[3] == '-') ? picolToInt(s+4) : 0);
+	return picolToInt(s);
+}
+
+static int toxdigit(int c) { return (c <= '9') ? (c-'0') : (10+((c|0x20)-'a')); }
+
+static int picolEscape(char *b, int n) {
+	char *s = strchr(b, '\\');
+	if (s) for (char *t = s; *s; ) {
+		if (*s == '\\')
+			switch (*(s+1)) {
+			default :
+				s++, n--;
+				if (picolIsGraph(*s)) break;
+				for (s++, n--; n > 0 && !picolIsGraph(*s); s++, n--);
+				continue;
+			case 'X': case 'x':
+				s+=2, n-=2;
+				if (picolIsXDigit(*s) && picolIsXDigit(*(s+1))) {
+					*t++ = (toxdigit(*s) << 4) | toxdigit(*(s+1));
+					s+=2, n--;
+				} else if (picolIsXDigit(*s)) {
+					*t++ = toxdigit(*s);
+					s++;
+				}
+				continue;
+			case 'n': s+=2, n--, *t++ = '\n'; continue;
+			case 'r': s+=2, n--, *t++ = '\r'; continue;
+			case 't': s+=2, n--, *t++ = '\t'; continue;
+			case'\0': s++, n--; continue;
+			}
+		*t++ = *s++;
+	}
+	b[n] = '\0';
+	return n;
+}
+
+static int picolEval(struct picolInterp *i, char *s);
+
+static char *picolToken(struct picolParser *p, int *tlen) {
+	*tlen = p->end-p->start+1;
+	if (*tlen < 0) *tlen = 0;
+	char *t = memcpy(malloc(*tlen+1), p->start, *tlen);
+	t[*tlen] = '\0';
+	return t;
+}
+
+static int picolSubst(struct picolInterp *i, char *s, char **out);
+
+static int picolSubstToken(struct picolInterp *i, int type, char **t, int *tlen) { /* *t is freed on error */
+	int retcode = PICOL_OK;
+	if (type == PT_VAR) {
+		size_t n, an = picolArrayName(*t,&n);
+		struct picolVar *v = NULL;
+		char *key = NULL;
+		if (an) {
+			(*t)[an] = (*t)[n-1] = '\0'; /* split name(key) in place */
+			if ((retcode = picolSubst(i,*t+an+1,&key)) == PICOL_OK && !(v = picolGetElem(i,*t,an,key,strlen(key))))
+				retcode = picolErr(i,"No such variable '%s(%s)'",*t,key);
+		} else if ((v = picolFindVar(i->callframe->vars,*t,n)) == NULL) {
+			retcode = picolErr(i,"No such variable '%s'",*t);
+		} else if (v->elems) {
+			retcode = picolErr(i,"Variable '%s' is an array",*t);
+		}
+		free(key), free(*t);
+		if (retcode != PICOL_OK) return retcode;
+		*t = strdup(v->val);
+		*tlen = strlen(*t);
+	} else if (type == PT_CMD) {
+		retcode = picolEval(i,*t);
+		free(*t);
+		if (retcode != PICOL_OK) return retcode;
+		*t = picolMoveResult(i);
+		*tlen = strlen(*t);
+	} else if (type == PT_ESC) {
+		*tlen = picolEscape(*t, *tlen);
+	}
+	return retcode;
+}
+
+static int picolSubst(struct picolInterp *i, char *s, char **out) { /* $, [] and backslashes only: quotes, braces and whitespace are kept */
+	struct picolParser p;
+	int retcode = PICOL_OK, tlen;
+	size_t n = 0;
+	picolInitParser(&p,s);
+	*out = strdup("");
+	while (p.len > 0) {
+		if (*p.pos == '$') picolParseVar(&p);
+		else if (*p.pos == '[') picolParseCommand(&p);
+		else {
+			for (p.start = p.pos; p.len > 0 && *p.pos != '$' && *p.pos != '['; p.pos++, p.len--)
+				if (*p.pos == '\\' && p.len >= 2) p.pos++, p.len--;
+			p.end = p.pos-1;
+			p.type = PT_ESC;
+		}
+		char *t = picolToken(&p,&tlen);
+		if ((retcode = picolSubstToken(i,p.type,&t,&tlen)) != PICOL_OK) break;
+		*out = realloc(*out, n+tlen+1);
+		memcpy(*out+n, t, tlen);
+		(*out)[n += tlen] = '\0';
+		free(t);
+	}
+	if (retcode != PICOL_OK) free(*out), *out = NULL;
+	return retcode;
+}
+
+static int picolEval(struct picolInterp *i, char *s) {
+	struct picolParser p;
+	int retcode = PICOL_OK, argc = 0, tlen;
+	char **argv = NULL;
+	picolSetResult(i,"");
+	picolInitParser(&p,s);
+	for (int prevtype = p.type; picolGetToken(&p) == PICOL_OK; prevtype = p.type) {
+		if (p.type == PT_EOF) break;
+		char *t = picolToken(&p,&tlen);
+		if (p.type == PT_SEP) {
+			free(t);
+			continue;
+		} else if (p.type == PT_EOL) {
+			struct picolCmd *c;
+			free(t);
+			if (argc) { /* We have a complete command + args. Call it! */
+				if ((c = picolGetCommand(i,argv[0])) == NULL) {
+					retcode = picolErr(i,"No such command '%s'",argv[0]);
+					break;
+				}
+				if (++i->cmdcount >= i->checkat && (retcode = picolCheckLimits(i)) != PICOL_OK) break;
+				retcode = c->func(i,argc,argv,c->privdata);
+				if (retcode != PICOL_OK) break;
+			}
+			/* Prepare for the next command */
+			picolFreeList(argc,argv);
+			argv = NULL;
+			argc = 0;
+			continue;
+		} else if ((retcode = picolSubstToken(i,p.type,&t,&tlen)) != PICOL_OK) {
+			break;
+		}
+		/* We have a new token, append to the previous or as new arg? */
+		if (prevtype == PT_SEP || prevtype == PT_EOL) {
+			argv = realloc(argv, sizeof(char*)*(argc+1));
+			argv[argc] = t;
+			argc++;
+		} else { /* Interpolation */
+			int oldlen = strlen(argv[argc-1]);
+			argv[argc-1] = realloc(argv[argc-1], oldlen+tlen+1);
+			memcpy(argv[argc-1]+oldlen, t, tlen);
+			argv[argc-1][oldlen+tlen]='\0';
+			free(t);
+		}
+	}
+	picolFreeList(argc,argv);
+	return retcode;
+}
+
+static int picolArityErr(struct picolInterp *i, char *name) {
+	return picolErr(i,"Wrong number of args for %s",name);
+}
+
+static int picolCommandMath(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 3) return picolArityErr(i,argv[0]);
+	int o = argv[0][0]^argv[0][1]<<8, a = picolToInt(argv[1]), b = picolToInt(argv[2]), c = 0;
+	/**/ if (o ==  '+') c = a + b;
+	else if (o ==  '-') c = a - b;
+	else if (o ==  '*') c = a * b;
+	else if (o ==  '/') c = a / b;
+	else if (o ==  '>') c = a > b;
+	else if (o == ('>'^'='<<8)) c = a >= b;
+	else if (o ==  '<') c = a < b;
+	else if (o == ('<'^'='<<8)) c = a <= b;
+	else if (o == ('='^'='<<8)) c = a == b;
+	else if (o == ('!'^'='<<8)) c = a != b;
+	picolSetIntResult(i,c);
+	return PICOL_OK;
+}
+
+static int picolCommandSet(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 3) return picolArityErr(i,argv[0]);
+	if (picolSetVar(i,argv[1],argv[2]) != PICOL_OK) return PICOL_ERR;
+	picolSetResult(i,argv[2]);
+	return PICOL_OK;
+}
+
+static int picolCommandIncr(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 2 && argc != 3) return picolArityErr(i,argv[0]);
+	struct picolVar *v;
+	if (picolUpdateVar(i,argv[1],&v) != PICOL_OK) return PICOL_ERR;
+	picolSetIntResult(i,picolToInt(v->val) + ((argc == 3) ? picolToInt(argv[2]) : 1));
+	picolSetVal(v,i->result);
+	return PICOL_OK;
+}
+
+static int picolCommandAppend(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc < 2) return picolArityErr(i,argv[0]);
+	struct picolVar *v;
+	if (picolUpdateVar(i,argv[1],&v) != PICOL_OK) return PICOL_ERR;
+	size_t n = strlen(v->val), z = n;
+	for (int j = 2; j < argc; j++) z += strlen(argv[j]);
+	v->val = realloc(v->val, z+1); /* grow in place once, then copy each value */
+	for (int j = 2; j < argc; n += strlen(argv[j++])) strcpy(v->val+n, argv[j]);
+	picolSetResult(i,v->val);
+	return PICOL_OK;
+}
+
+static int picolCommandPuts(struct picolInterp *i, int argc, char **argv, void *pd) {
+    if (argc != 2) return picolArityErr(i,argv[0]);
+    puts(argv[1]);
+	return PICOL_OK;
+}
+
+static int picolCommandIf(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 3 && argc != 5) return picolArityErr(i,argv[0]);
+	for (int retcode = picolEval(i,argv[1]); retcode != PICOL_OK; ) return retcode;
+	if (picolToInt(i->result)) return picolEval(i,argv[2]);
+	if (argc == 5) return picolEval(i,argv[4]);
+	return PICOL_OK;
+}
+
+static int picolCommandWhile(struct picolInterp *i, int argc, char **argv, void *pd) {
+	for (int retcode; argc == 3; )
+		if ((retcode = picolEval(i,argv[1])) != PICOL_OK) return retcode;
+		else if (picolToInt(i->result) == 0) return PICOL_OK;
+		else if ((retcode = picolEval(i,argv[2])) == PICOL_CONTINUE) continue;
+		else if (retcode == PICOL_OK) continue;
+		else if (retcode != PICOL_BREAK) return retcode;
+	return picolArityErr(i,argv[0]);
+}
+
+static int picolCommandForeach(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 4) return picolArityErr(i,argv[0]);
+	int n, retcode = PICOL_OK;
+	char **v = picolSplitList(argv[2],&n);
+	for (int j = 0; j < n; j++) {
+		if ((retcode = picolSetVar(i,argv[1],v[j])) != PICOL_OK) break;
+		if ((retcode = picolEval(i,argv[3])) == PICOL_OK || retcode == PICOL_CONTINUE) continue;
+		if (retcode == PICOL_BREAK) retcode = PICOL_OK;
+		break;
+	}
+	picolFreeList(n,v);
+	if (retcode == PICOL_CONTINUE) retcode = PICOL_OK;
+	if (retcode == PICOL_OK) picolSetResult(i,"");
+	return retcode;
+}
+
+static int picolCommandRetCodes(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 1) return picolArityErr(i,argv[0]);
+	if (strcmp(argv[0],"break") == 0) return PICOL_BREAK;
+	if (strcmp(argv[0],"continue") == 0) return PICOL_CONTINUE;
+	return PICOL_OK;
+}
+
+static void picolFreeVars(struct picolVar *v) {
+	for (struct picolVar *t; v != NULL; v = t) {
+		t = v->next;
+		if (v->elems) {
+			for (int j = 0; j < PICOL_ARRHASH; j++) picolFreeVars(v->elems[j]);
+			free(v->elems);
+		}
+		free(v->val);
+		free(v);
+	}
+}
+
+static void picolDropCallFrame(struct picolInterp *i) {
+	struct picolCallFrame *cf = i->callframe;
+	picolFreeVars(cf->vars);
+	i->callframe = cf->parent;
+	if (i->nspare == PICOL_SPAREFRAMES) { free(cf); return; } /* deep recursion doesn't pin its frames */
+	cf->parent = i->spareframes;
+	i->spareframes = cf;
+	i->nspare++;
+}
+
+static int picolCommandCallProc(struct picolInterp *i, int argc, char **argv, void *pd) {
+	struct picolProc *p = pd;
+	if (argc-1 != p->arity) return picolErr(i,"Proc '%s' called with wrong arg num",argv[0]);
+	struct picolCallFrame *cf = i->spareframes;
+	if (cf) i->spareframes = cf->parent, i->nspare--;
+	else cf = malloc(sizeof(*cf));
+	cf->vars = NULL;
+	cf->parent = i->callframe;
+	i->callframe = cf;
+	for (int j = 0; j < p->arity; j++) picolSetVar(i,p->args[j],argv[j+1]);
+	int errcode = picolEval(i,p->body);
+	if (errcode == PICOL_RETURN) errcode = PICOL_OK;
+	picolDropCallFrame(i); /* remove the called proc callframe */
+	return errcode;
+}
+
+static int picolCommandProc(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 4) return picolArityErr(i,argv[0]);
+	int arity = 0;
+	size_t na = strlen(argv[2])+1, nb = strlen(argv[3])+1;
+	for (char const *s = argv[2]; *(s += strspn(s," ")); s += strcspn(s," ")) arity++;
+	struct picolProc *p = malloc(sizeof(*p)+sizeof(char*)*arity+na+nb);
+	char *alist = memcpy((char*)((p->args = (char**)(p+1))+arity), argv[2], na); /* arguments list */
+	p->body = memcpy(alist+na, argv[3], nb); /* procedure body */
+	p->arity = 0;
+	for (char *s = alist; *(s += strspn(s," ")); ) { /* split once here rather than per call */
+		p->args[p->arity++] = s;
+		if (*(s += strcspn(s," "))) *s++ = '\0';
+	}
+	if (picolRegisterCommand(i,argv[1],picolCommandCallProc,p) == PICOL_OK) return PICOL_OK;
+	free(p);
+	return PICOL_ERR;
+}
+
+static int picolCommandReturn(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 1 && argc != 2) return picolArityErr(i,argv[0]);
+	picolSetResult(i, (argc == 2) ? argv[1] : "");
+	return PICOL_RETURN;
+}
+
+static int picolCommandCatch(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 2 && argc != 3) return picolArityErr(i,argv[0]);
+	int retcode = picolEval(i,argv[1]);
+	if (retcode == PICOL_LIMIT) return retcode; /* limits unwind through catch */
+	if (argc == 3 && picolSetVar(i,argv[2],i->result) != PICOL_OK) return PICOL_ERR;
+	picolSetIntResult(i,retcode);
+	return PICOL_OK;
+}
+
+static int picolCommandLimit(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 3) return picolArityErr(i,argv[0]);
+	long n = picolToInt(argv[2]);
+	if (strcmp(argv[1],"commands") == 0) i->cmdlimit = (n > 0) ? i->cmdcount+n : 0;
+	else if (strcmp(argv[1],"time") == 0) i->deadline = (n > 0) ? clock()+n*(CLOCKS_PER_SEC/1000.0) : 0;
+	else return picolErr(i,"Bad limit '%s', must be commands or time",argv[1]);
+	i->checkat = i->cmdcount+1; /* recompute on the next dispatch */
+	picolSetResult(i,"");
+	return PICOL_OK;
+}
+
+static int picolDictCompare(char const *a, char const *b) { /* embedded numbers by value, case as tie-break */
+	int tie = 0;
+	while (*a && *b)
+		if (picolIsDigit(*a) && picolIsDigit(*b)) {
+			while (*a == '0' && picolIsDigit(a[1])) a++;
+			while (*b == '0' && picolIsDigit(b[1])) b++;
+			size_t na = strspn(a,"0123456789"), nb = strspn(b,"0123456789");
+			int c = (na != nb) ? (na > nb)-(na < nb) : strncmp(a,b,na);
+			if (c) return c;
+			a += na, b += nb;
+		} else {
+			int ca = (unsigned char)*a, cb = (unsigned char)*b;
+			if (ca != cb && !tie) tie = ca-cb;
+			if ((unsigned)ca-'A' < 26u) ca |= 0x20;
+			if ((unsigned)cb-'A' < 26u) cb |= 0x20;
+			if (ca != cb) return ca-cb;
+			a++, b++;
+		}
+	return *a ? 1 : *b ? -1 : tie;
+}
+
+static int picolSortCompare(struct picolSort *ps, struct picolSortItem *a, struct picolSortItem *b) {
+	int c = 0;
+	if (ps->retcode != PICOL_OK) return 0;
+	if (ps->mode == PS_ASCII) c = strcmp(a->s,b->s);
+	else if (ps->mode == PS_DICTIONARY) c = picolDictCompare(a->s,b->s);
+	else if (ps->mode == PS_INTEGER) c = (a->ikey > b->ikey)-(a->ikey < b->ikey); /* exact past 2^53 */
+	else if (ps->mode == PS_REAL) c = (a->key > b->key)-(a->key < b->key);
+	else {
+		size_t n = strlen(ps->cmd);
+		char *script = picolListAppend(picolListAppend(strdup(ps->cmd),&n,a->s),&n,b->s);
+		if ((ps->retcode = picolEval(ps->i,script)) == PICOL_OK) c = picolToInt(ps->i->result);
+		free(script);
+	}
+	return ps->order*c;
+}
+
+static void picolMergeSort(struct picolSort *ps, struct picolSortItem *v, struct picolSortItem *t, int n) {
+	if (n < 2) return; /* stable: t holds the left half while the halves merge back into v */
+	int m = n/2;
+	picolMergeSort(ps,v,t,m);
+	picolMergeSort(ps,v+m,t,n-m);
+	memcpy(t,v,sizeof(*v)*m);
+	for (int a = 0, b = m, k = 0; a < m; )
+		v[k++] = (b < n && picolSortCompare(ps,&v[b],&t[a]) < 0) ? v[b++] : t[a++];
+}
+
+static int picolListResult(struct picolInterp *i, int argc, char **argv) {
+	size_t n = 0;
+	char *l = strdup("");
+	for (int j = 0; j < argc; j++) l = picolListAppend(l,&n,argv[j]);
+	free(i->result);
+	i->result = l;
+	return PICOL_OK;
+}
+
+static int picolCommandList(struct picolInterp *i, int argc, char **argv, void *pd) {
+	return picolListResult(i,argc-1,argv+1);
+}
+
+static int picolCommandLlength(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 2) return picolArityErr(i,argv[0]);
+	int n;
+	char **v = picolSplitList(argv[1],&n); /* n is set before picolFreeList reads it */
+	picolFreeList(n,v);
+	picolSetIntResult(i,n);
+	return PICOL_OK;
+}
+
+static int picolCommandLindex(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 3) return picolArityErr(i,argv[0]);
+	int n;
+	char **v = picolSplitList(argv[1],&n);
+	int j = picolListIndex(argv[2],n);
+	picolSetResult(i,(j >= 0 && j < n) ? v[j] : "");
+	picolFreeList(n,v);
+	return PICOL_OK;
+}
+
+static int picolCommandLrange(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 4) return picolArityErr(i,argv[0]);
+	int n;
+	char **v = picolSplitList(argv[1],&n);
+	int first = picolListIndex(argv[2],n), last = picolListIndex(argv[3],n);
+	if (first < 0) first = 0;
+	if (last >= n) last = n-1;
+	if (last < first) first = 0, last = -1; /* empty, without indexing past v */
+	picolListResult(i,last-first+1,(n > 0) ? v+first : v);
+	picolFreeList(n,v);
+	return PICOL_OK;
+}
+
+static int picolCommandLinsert(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc < 3) return picolArityErr(i,argv[0]);
+	int n, k = argc-3;
+	char **v = picolSplitList(argv[1],&n), **w = malloc(sizeof(char*)*(n+k+1));
+	int j = picolListIndex(argv[2],n+1); /* end is after the last element */
+	if (j < 0) j = 0;
+	if (j > n) j = n;
+	if (n > 0) memcpy(w,v,sizeof(char*)*j); /* v is NULL for an empty list */
+	memcpy(w+j,argv+3,sizeof(char*)*k);
+	if (n > 0) memcpy(w+j+k,v+j,sizeof(char*)*(n-j));
+	picolListResult(i,n+k,w);
+	free(w);
+	picolFreeList(n,v);
+	return PICOL_OK;
+}
+
+static int picolCommandLappend(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc < 2) return picolArityErr(i,argv[0]);
+	struct picolVar *v;
+	if (picolUpdateVar(i,argv[1],&v) != PICOL_OK) return PICOL_ERR;
+	size_t n = strlen(v->val);
+	for (int j = 2; j < argc; j++) v->val = picolListAppend(v->val,&n,argv[j]); /* in place */
+	picolSetResult(i,v->val);
+	return PICOL_OK;
+}
+
+static int picolCommandLset(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 4) return picolArityErr(i,argv[0]);
+	struct picolVar *var = picolGetVar(i,argv[1]);
+	if (!var) return picolErr(i,"No such variable '%s'",argv[1]);
+	if (var->elems) return picolErr(i,"Variable '%s' is an array",argv[1]);
+	int n;
+	char **v = picolSplitList(var->val,&n), *old;
+	int j = picolListIndex(argv[2],n);
+	if (j < 0 || j >= n) {
+		picolFreeList(n,v);
+		return picolErr(i,"List index out of range");
+	}
+	old = v[j], v[j] = argv[3];
+	picolListResult(i,n,v);
+	v[j] = old;
+	picolFreeList(n,v);
+	picolSetVal(var,i->result);
+	return PICOL_OK;
+}
+
+static int picolDictFind(int n, char **v, char const *key) { /* index of key, the last one wins */
+	for (int j = n-2; j >= 0; j -= 2)
+		if (strcmp(v[j],key) == 0) return j;
+	return -1;
+}
+
+static int picolDictPut(char **v, int n, char *key, char *val) { /* v has room for one more pair */
+	int j = picolDictFind(n,v,key);
+	if (j >= 0) return v[j+1] = val, n;
+	v[n] = key, v[n+1] = val;
+	return n+2;
+}
+
+static char **picolDictSplit(struct picolInterp *i, char const *s, int *n) { /* *n < 0 on error */
+	char **v = picolSplitList(s,n);
+	if (*n%2 == 0) return v;
+	picolFreeList(*n,v);
+	*n = -1;
+	picolErr(i,"Missing value to go with key");
+	return NULL;
+}
+
+static int picolCommandDict(struct picolInterp *i, int argc, char **argv, void *pd) {
+	int n = 0, j, retcode = PICOL_OK;
+	char **v = NULL, **w;
+	if (argc < 2) return picolArityErr(i,argv[0]);
+	if (strcmp(argv[1],"create") == 0) {
+		if (argc%2) return picolArityErr(i,argv[0]);
+		w = malloc(sizeof(char*)*argc);
+		for (j = 2; j < argc; j += 2) n = picolDictPut(w,n,argv[j],argv[j+1]);
+		picolListResult(i,n,w);
+		free(w);
+		return PICOL_OK;
+	} else if (strcmp(argv[1],"set") == 0) {
+		if (argc != 5) return picolArityErr(i,argv[0]);
+		struct picolVar *var;
+		if (picolUpdateVar(i,argv[2],&var) != PICOL_OK) return PICOL_ERR;
+		if ((v = picolDictSplit(i,var->val,&n)), n < 0) return PICOL_ERR;
+		if (w = malloc(sizeof(char*)*(n+2)), n > 0) memcpy(w,v,sizeof(char*)*n);
+		picolListResult(i,picolDictPut(w,n,argv[3],argv[4]),w);
+		free(w);
+		picolSetVal(var,i->result);
+	} else if (strcmp(argv[1],"get") == 0 || strcmp(argv[1],"exists") == 0) {
+		if (argc != 4 && (argc != 3 || argv[1][0] != 'g')) return picolArityErr(i,argv[0]);
+		if ((v = picolDictSplit(i,argv[2],&n)), n < 0) return PICOL_ERR;
+		if (argc == 3) picolSetResult(i,argv[2]);
+		else if (argv[1][0] == 'e') picolSetIntResult(i,picolDictFind(n,v,argv[3]) >= 0);
+		else if ((j = picolDictFind(n,v,argv[3])) >= 0) picolSetResult(i,v[j+1]);
+		else retcode = picolErr(i,"Key '%s' not known in dictionary",argv[3]);
+	} else if (strcmp(argv[1],"keys") == 0) {
+		if (argc != 3) return picolArityErr(i,argv[0]);
+		if ((v = picolDictSplit(i,argv[2],&n)), n < 0) return PICOL_ERR;
+		w = malloc(sizeof(char*)*(n/2+1));
+		for (j = 0; j < n; j += 2) w[j/2] = v[j];
+		picolListResult(i,n/2,w);
+		free(w);
+	} else if (strcmp(argv[1],"for") == 0) {
+		if (argc != 5) return picolArityErr(i,argv[0]);
+		int k;
+		char **kv = picolSplitList(argv[2],&k);
+		if (k != 2) retcode = picolErr(i,"Must have exactly two variable names");
+		else if ((v = picolDictSplit(i,argv[3],&n)), n < 0) retcode = PICOL_ERR, n = 0;
+		for (j = 0; j < n && retcode == PICOL_OK; j += 2) {
+			if (picolSetVar(i,kv[0],v[j]) != PICOL_OK || picolSetVar(i,kv[1],v[j+1]) != PICOL_OK) retcode = PICOL_ERR;
+			else if ((retcode = picolEval(i,argv[4])) == PICOL_CONTINUE) retcode = PICOL_OK;
+		}
+		picolFreeList(k,kv);
+		if (retcode == PICOL_BREAK) retcode = PICOL_OK;
+		if (retcode == PICOL_OK) picolSetResult(i,"");
+	} else return picolErr(i,"Bad option '%s' for %s",argv[1],argv[0]);
+	picolFreeList(n,v);
+	return retcode;
+}
+
+static void picolBufAppend(char **b, size_t *n, size_t *z, char const *s, size_t k) { /* amortized growth */
+	if (*n+k >= *z) *b = realloc(*b, (*z = 2*(*n+k)+16));
+	memcpy(*b+*n, s, k);
+	(*b)[*n += k] = '\0';
+}
+
+static long picolStrFirst(char const *h, size_t n, char const *s, size_t k, size_t from) {
+	if (k == 0 || k > n || from > n-k) return -1; /* no room for s at or after from */
+	for (char const *p = h+from, *e = h+n-k+1; p < e && (p = memchr(p,*s,e-p)) != NULL; p++)
+		if (p[k-1] == s[k-1] && memcmp(p,s,k) == 0) return p-h; /* first byte, last byte, then the rest */
+	return -1;
+}
+
+static long picolStrLast(char const *h, size_t n, char const *s, size_t k, size_t to) {
+	if (k == 0 || k > n) return -1;
+	for (size_t j = (to < n-k) ? to+1 : n-k+1; j-- > 0; )
+		if (h[j] == *s && h[j+k-1] == s[k-1] && memcmp(h+j,s,k) == 0) return j;
+	return -1;
+}
+
+static int picolStrMap(struct picolInterp *i, char *map, char const *s) {
+	int m;
+	char **v = picolDictSplit(i,map,&m), *b = NULL, first[256] = {0};
+	if (m < 0) return PICOL_ERR;
+	size_t n = strlen(s), len = 0, z = 0, *kl = malloc(sizeof(size_t)*(m/2+1));
+	for (int j = 0; j < m; j += 2) if ((kl[j/2] = strlen(v[j])) > 0) first[(unsigned char)*v[j]] = 1;
+	picolBufAppend(&b,&len,&z,"",0);
+	for (size_t p = 0, q; p < n; ) { /* one pass; only bytes that start some key are tried */
+		for (q = p; q < n && !first[(unsigned char)s[q]]; q++);
+		picolBufAppend(&b,&len,&z,s+p,q-p);
+		if ((p = q) == n) break;
+		int j = 0;
+		while (j < m && !(kl[j/2] && kl[j/2] <= n-p && memcmp(s+p,v[j],kl[j/2]) == 0)) j += 2;
+		if (j < m) picolBufAppend(&b,&len,&z,v[j+1],strlen(v[j+1])), p += kl[j/2];
+		else picolBufAppend(&b,&len,&z,s+p,1), p++;
+	}
+	free(i->result);
+	i->result = b;
+	free(kl);
+	picolFreeList(m,v);
+	return PICOL_OK;
+}
+
+static int picolCommandString(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc < 3) return picolArityErr(i,argv[0]);
+	char *s = argv[2];
+	size_t n = strlen(s); /* once; every subcommand works from it */
+	if (strcmp(argv[1],"length") == 0 && argc == 3) {
+		picolSetIntResult(i,n);
+	} else if (strcmp(argv[1],"index") == 0 && argc == 4) {
+		int j = picolListIndex(argv[3],n), in = (j >= 0 && (size_t)j < n);
+		picolSetResultLen(i,in ? s+j : s,in);
+	} else if (strcmp(argv[1],"range") == 0 && argc == 5) {
+		int first = picolListIndex(argv[3],n), last = picolListIndex(argv[4],n);
+		if (first < 0) first = 0;
+		if (last >= (int)n) last = (int)n-1;
+		if (last < first) first = 0, last = -1; /* empty, without pointing past s */
+		picolSetResultLen(i,s+first,last-first+1);
+	} else if ((strcmp(argv[1],"equal") == 0 || strcmp(argv[1],"compare") == 0) && argc == 4) {
+		int c = strcmp(s,argv[3]);
+		picolSetIntResult(i,(argv[1][0] == 'e') ? (c == 0) : (c > 0)-(c < 0));
+	} else if (strcmp(argv[1],"repeat") == 0 && argc == 4) {
+		int count = picolToInt(argv[3]);
+		size_t z = (count > 0) ? n*count : 0, k = (z > 0) ? n : 0;
+		free(i->result);
+		i->result = malloc(z+1);
+		memcpy(i->result,s,k);
+		for (; k < z; k *= 2) memcpy(i->result+k, i->result, (k < z-k) ? k : z-k); /* doubling */
+		i->result[z] = '\0';
+	} else if ((strcmp(argv[1],"first") == 0 || strcmp(argv[1],"last") == 0) && (argc == 4 || argc == 5)) {
+		size_t hn = strlen(argv[3]);
+		int at = (argc == 5) ? picolListIndex(argv[4],hn) : (argv[1][0] == 'f') ? 0 : (int)hn;
+		if (argv[1][0] == 'f') picolSetIntResult(i,picolStrFirst(argv[3],hn,s,n,(at > 0) ? at : 0));
+		else picolSetIntResult(i,(at < 0) ? -1 : picolStrLast(argv[3],hn,s,n,at));
+	} else if (strcmp(argv[1],"map") == 0 && argc == 4) {
+		return picolStrMap(i,s,argv[3]);
+	} else {
+		char *opts[] = {"length","index","range","equal","compare","repeat","first","last","map"};
+		for (int j = 0; j < (int)(sizeof(opts)/sizeof(char*)); j++)
+			if (strcmp(argv[1],opts[j]) == 0) return picolArityErr(i,argv[0]);
+		return picolErr(i,"Bad option '%s' for %s",argv[1],argv[0]);
+	}
+	return PICOL_OK;
+}
+
+static int picolReEmit(struct picolRegex *re, int op, int x, int y) {
+	if (re->n%16 == 0) re->code = realloc(re->code, sizeof(*re->code)*(re->n+16));
+	memset(&re->code[re->n], 0, sizeof(*re->code));
+	re->code[re->n].op = op, re->code[re->n].x = x, re->code[re->n].y = y;
+	return re->n++;
+}
+
+static void picolReInsert(struct picolRegex *re, int at, int op, int x, int y) { /* jumps are relative, so code can move */
+	picolReEmit(re,op,x,y);
+	struct picolReInst t = re->code[re->n-1];
+	memmove(&re->code[at+1], &re->code[at], sizeof(t)*(re->n-1-at));
+	re->code[at] = t;
+}
+
+static int picolReHasBit(unsigned char const *set, int c) { return (set[(unsigned char)c >> 3] >> (c & 7)) & 1; }
+static void picolReSetBit(unsigned char *set, int c) { set[(unsigned char)c >> 3] |= 1 << (c & 7); }
+
+static int picolReEscChar(int c) {
+	return (c == 'n') ? '\n' : (c == 't') ? '\t' : (c == 'r') ? '\r' : (c == 'f') ? '\f' : (c == 'v') ? '\v' : c;
+}
+
+static int picolReClassEscape(int e, unsigned char *set) { /* \d \w \s and their negations */
+	if (!strchr("dwsDWS",e) || e == '\0') return 0;
+	for (int c = 0, l = e|0x20; c < 256; c++)
+		if (((l == 'd' && picolIsDigit(c)) || (l == 'w' && (picolIsAlnum(c) || c == '_'))
+				|| (l == 's' && c && strchr(" \t\n\r\f\v",c))) == (e == l)) picolReSetBit(set,c);
+	return 1;
+}
+
+static void picolReAlt(struct picolRegex *re, char const **s, char const **err);
+
+static void picolReAtom(struct picolRegex *re, char const **s, char const **err) {
+	char const *p = *s;
+	int c = (unsigned char)*p++;
+	unsigned char set[32] = {0};
+	if (c == '(') {
+		int cap = !(p[0] == '?' && p[1] == ':'), k = cap ? ++re->nsub : 0;
+		if (cap) picolReEmit(re,RE_SAVE,2*k,0);
+		else p += 2;
+		*s = p;
+		picolReAlt(re,s,err);
+		if (*err) return;
+		if (**s != ')') { *err = "unmatched ("; return; }
+		(*s)++;
+		if (cap) picolReEmit(re,RE_SAVE,2*k+1,0);
+		return;
+	}
+	if (c == '\0' || strchr("*+?{",c)) { *err = "nothing to repeat"; return; }
+	if (c == '\\' && *p >= '1' && *p <= '9') { *err = "back references are not supported"; return; }
+	if (c == '[') {
+		int neg = (*p == '^');
+		p += neg;
+		for (char const *b = p; *p && (*p != ']' || p == b); ) {
+			int lo = (unsigned char)*p++, hi;
+			if (lo == '\\' && *p && picolReClassEscape(*p,set)) { p++; continue; }
+			if (lo == '\\' && *p) lo = picolReEscChar((unsigned char)*p++);
+			hi = lo;
+			if (*p == '-' && p[1] && p[1] != ']') {
+				hi = (unsigned char)p[1], p += 2;
+				if (hi == '\\' && *p) hi = picolReEscChar((unsigned char)*p++);
+			}
+			for (; lo <= hi; lo++) picolReSetBit(set,lo);
+		}
+		if (*p++ != ']') { *err = "unmatched ["; return; }
+		if (neg) for (int j = 0; j < 32; j++) set[j] = ~set[j];
+	} else if (c == '\\' && *p && picolReClassEscape(*p,set)) {
+		p++;
+	} else if (c == '.' || c == '^' || c == '$') {
+		*s = p;
+		picolReEmit(re,(c == '.') ? RE_ANY : (c == '^') ? RE_BOL : RE_EOL,0,0);
+		return;
+	} else {
+		if (c == '\\' && *p) c = picolReEscChar((unsigned char)*p++);
+		if (!re->nocase || !picolIsAlnum(c) || picolIsDigit(c)) {
+			*s = p;
+			picolReEmit(re,RE_CHAR,c,0);
+			return;
+		}
+		picolReSetBit(set,c);
+	}
+	*s = p;
+	for (c = 'a'; re->nocase && c <= 'z'; c++) /* fold case into the set */
+		if (picolReHasBit(set,c) || picolReHasBit(set,c-0x20)) picolReSetBit(set,c), picolReSetBit(set,c-0x20);
+	c = picolReEmit(re,RE_CLASS,0,0); /* emit first, it may move re->code */
+	memcpy(re->code[c].set, set, sizeof(set));
+}
+
+static int picolReTooBig(struct picolRegex *re, size_t n) { return n*(2*re->nsub+3) > PICOL_REMAX; }
+
+static void picolReQuantify(struct picolRegex *re, int start, int min, int max, int lazy, char const **err) {
+	int len = re->n-start, at = start;
+	if (picolReTooBig(re,start+(size_t)(min+((max < 0) ? 1 : max-min))*(len+2))) { *err = "regexp too big"; return; }
+	struct picolReInst *block = memcpy(malloc(sizeof(*block)*len+1), &re->code[start], sizeof(*block)*len);
+	re->n = start;
+	for (int k = 0; k < min; k++) /* mandatory copies */
+		for (int j = (at = re->n, 0); j < len; j++) picolReEmit(re,0,0,0), re->code[re->n-1] = block[j];
+	if (max < 0 && min > 0) { /* the last copy loops back */
+		int j = picolReEmit(re,RE_SPLIT,at-re->n,1);
+		if (lazy) re->code[j].x = 1, re->code[j].y = at-j;
+	}
+	for (int k = min; k < max || (max < 0 && min == 0 && k == 0); k++) { /* optional copies, or a star */
+		at = re->n;
+		for (int j = 0; j < len; j++) picolReEmit(re,0,0,0), re->code[re->n-1] = block[j];
+		picolReInsert(re,at,RE_SPLIT,1,0);
+		if (max < 0) picolReEmit(re,RE_JMP,at-re->n,0);
+		re->code[at].y = re->n-at;
+		if (lazy) re->code[at].x = re->n-at, re->code[at].y = 1;
+	}
+	free(block);
+}
+
+static void picolReRepeat(struct picolRegex *re, char const **s, char const **err) {
+	int start = re->n;
+	picolReAtom(re,s,err);
+	if (!*err && picolReTooBig(re,re->n)) *err = "regexp too big";
+	while (!*err && **s && strchr("*+?{",**s)) {
+		int op = *(*s)++, min = (op == '+'), max = (op == '?') ? 1 : -1;
+		if (op == '{') {
+			char *e;
+			min = max = strtol(*s,&e,10);
+			if (*e == ',') max = picolIsDigit(e[1]) ? strtol(e+1,&e,10) : (e++, -1);
+			if (e == *s || *e != '}' || min > 255 || max > 255 || (max >= 0 && max < min)) {
+				*err = "bad repetition count";
+				return;
+			}
+			*s = e+1;
+		}
+		int lazy = (**s == '?');
+		*s += lazy;
+		picolReQuantify(re,start,min,max,lazy,err);
+	}
+}
+
+static void picolReAlt(struct picolRegex *re, char const **s, char const **err) {
+	int start = re->n;
+	while (**s && **s != '|' && **s != ')' && !*err) picolReRepeat(re,s,err);
+	while (**s == '|' && !*err) {
+		(*s)++;
+		picolReInsert(re,start,RE_SPLIT,1,0);
+		int j = picolReEmit(re,RE_JMP,0,0);
+		re->code[start].y = j+1-start;
+		while (**s && **s != '|' && **s != ')' && !*err) picolReRepeat(re,s,err);
+		re->code[j].x = re->n-j;
+		if (!*err && picolReTooBig(re,re->n)) *err = "regexp too big";
+	}
+}
+
+static void picolReFree(struct picolRegex *re) {
+	free(re->pattern);
+	free(re->code);
+	free(re);
+}
+
+static struct picolRegex *picolReCompile(struct picolInterp *i, char *pattern, int nocase) { /* cached per interp */
+	struct picolRegex **pp = &i->regexps, *re;
+	int count = 0;
+	for (; (re = *pp) != NULL; pp = &re->next, count++)
+		if (re->nocase == nocase && strcmp(re->pattern,pattern) == 0) {
+			*pp = re->next; /* move to front */
+			re->next = i->regexps;
+			return i->regexps = re;
+		}
+	char const *s = pattern, *err = NULL;
+	re = calloc(1,sizeof(*re));
+	re->pattern = strdup(pattern);
+	re->nocase = nocase;
+	picolReEmit(re,RE_SAVE,0,0);
+	picolReAlt(re,&s,&err);
+	if (!err && *s) err = "unmatched )";
+	if (err) {
+		picolErr(i,"Bad regexp '%s': %s",pattern,err);
+		picolReFree(re);
+		return NULL;
+	}
+	picolReEmit(re,RE_SAVE,1,0);
+	picolReEmit(re,RE_MATCH,0,0);
+	if (count >= PICOL_RECACHE) { /* drop the least recently used */
+		for (pp = &i->regexps; (*pp)->next != NULL; pp = &(*pp)->next);
+		picolReFree(*pp);
+		*pp = NULL;
+	}
+	re->next = i->regexps;
+	return i->regexps = re;
+}
+
+struct picolReList {
+	int n, *pc, *caps;
+};
+
+static void picolReAdd(struct picolRegex *re, struct picolReList *l, int *mark, int *stack, int pc, int *caps, size_t sp, size_t n) {
+	/* follows jumps, splits, anchors and saves depth first, x before y; the stack holds (pc, 0) to visit or
+	   (-1-slot, old) to restore a capture, and each instruction pushes at most two, so 2*re->n+1 pairs suffice */
+	int top = 0;
+	for (stack[top++] = pc, stack[top++] = 0; top > 0; ) {
+		int old = stack[--top];
+		if ((pc = stack[--top]) < 0) { caps[-1-pc] = old; continue; }
+		struct picolReInst *in = &re->code[pc];
+		if (mark[pc] == (int)sp+1) continue; /* already on this list, with higher priority */
+		mark[pc] = sp+1;
+		if (in->op == RE_JMP) stack[top++] = pc+in->x, stack[top++] = 0;
+		else if (in->op == RE_SPLIT) stack[top++] = pc+in->y, stack[top++] = 0, stack[top++] = pc+in->x, stack[top++] = 0;
+		else if (in->op == RE_BOL) { if (sp == 0) stack[top++] = pc+1, stack[top++] = 0; }
+		else if (in->op == RE_EOL) { if (sp == n) stack[top++] = pc+1, stack[top++] = 0; }
+		else if (in->op == RE_SAVE) {
+			stack[top++] = -1-in->x, stack[top++] = caps[in->x];
+			caps[in->x] = sp;
+			stack[top++] = pc+1, stack[top++] = 0;
+		} else {
+			int ns = 2*(re->nsub+1);
+			l->pc[l->n] = pc;
+			memcpy(l->caps+ns*l->n++, caps, sizeof(int)*ns);
+		}
+	}
+}
+
+static int picolReMatch(struct picolRegex *re, char const *s, size_t n, size_t from, int *caps) {
+	/* Pike VM: every thread steps in lockstep over s, so time is linear in n, with no backtracking */
+	int ns = 2*(re->nsub+1), found = 0;
+	int *mem = malloc(sizeof(int)*(re->n*(2+2*ns)+re->n+ns+4*re->n+2)), *mark = mem, *start = mark+re->n;
+	int *stack = start+ns+re->n*(2+2*ns); /* for picolReAdd */
+	struct picolReList l[2] = {{0, start+ns, start+ns+re->n}, {0, start+ns+re->n*(1+ns), start+ns+re->n*(2+ns)}};
+	struct picolReList *cl = &l[0], *nl = &l[1], *t;
+	for (int j = 0; j < re->n; j++) mark[j] = 0;
+	for (size_t sp = from; sp <= n; sp++, t = cl, cl = nl, nl = t) {
+		if (!found) {
+			for (int j = 0; j < ns; j++) start[j] = -1;
+			picolReAdd(re,cl,mark,stack,0,start,sp,n);
+		}
+		if (cl->n == 0 && found) break; /* otherwise a later start may still match */
+		nl->n = 0;
+		for (int k = 0; k < cl->n; k++) {
+			struct picolReInst *in = &re->code[cl->pc[k]];
+			int c = (sp < n) ? (unsigned char)s[sp] : -1;
+			if (in->op == RE_MATCH) { /* lower priority threads are cut off */
+				memcpy(caps, cl->caps+ns*k, sizeof(int)*ns);
+				found = 1;
+				break;
+			}
+			if (c >= 0 && (in->op == RE_ANY || (in->op == RE_CHAR && in->x == c) || (in->op == RE_CLASS && picolReHasBit(in->set,c))))
+				picolReAdd(re,nl,mark,stack,cl->pc[k]+1,cl->caps+ns*k,sp+1,n);
+		}
+		cl->n = 0;
+	}
+	free(mem);
+	return found;
+}
+
+static int picolReOptions(struct picolInterp *i, int argc, char **argv, int *nocase, int *all) { /* index of the pattern */
+	int j = 1;
+	for (; j < argc && argv[j][0] == '-'; j++)
+		if (strcmp(argv[j],"-nocase") == 0) *nocase = 1;
+		else if (all && strcmp(argv[j],"-all") == 0) *all = 1;
+		else if (strcmp(argv[j],"--") == 0) return j+1;
+		else return picolErr(i,"Bad option '%s' for %s",argv[j],argv[0]), -1;
+	return j;
+}
+
+static int picolCommandRegexp(struct picolInterp *i, int argc, char **argv, void *pd) {
+	int nocase = 0, j = picolReOptions(i,argc,argv,&nocase,NULL);
+	if (j < 0) return PICOL_ERR;
+	if (argc-j < 2) return picolArityErr(i,argv[0]);
+	struct picolRegex *re = picolReCompile(i,argv[j],nocase);
+	if (re == NULL) return PICOL_ERR;
+	int *caps = malloc(sizeof(int)*2*(re->nsub+1)), matched = picolReMatch(re,argv[j+1],strlen(argv[j+1]),0,caps);
+	for (int k = j+2, g = 0; matched > 0 && k < argc; k++, g++) { /* matchVar, then one var per group */
+		int b = (g <= re->nsub) ? caps[2*g] : -1, e = (b >= 0) ? caps[2*g+1] : -1;
+		picolSetResultLen(i,argv[j+1]+((b >= 0) ? b : 0),e-b);
+		if (picolSetVar(i,argv[k],i->result) != PICOL_OK) matched = -1;
+	}
+	free(caps);
+	if (matched < 0) return PICOL_ERR;
+	picolSetIntResult(i,matched);
+	return PICOL_OK;
+}
+
+static int picolCommandRegsub(struct picolInterp *i, int argc, char **argv, void *pd) {
+	int nocase = 0, all = 0, count = 0, j = picolReOptions(i,argc,argv,&nocase,&all);
+	if (j < 0) return PICOL_ERR;
+	if (argc-j != 3 && argc-j != 4) return picolArityErr(i,argv[0]);
+	struct picolRegex *re = picolReCompile(i,argv[j],nocase);
+	if (re == NULL) return PICOL_ERR;
+	char *s = argv[j+1], *b = NULL;
+	size_t n = strlen(s), pos = 0, len = 0, z = 0;
+	int *caps = malloc(sizeof(int)*2*(re->nsub+1));
+	picolBufAppend(&b,&len,&z,"",0);
+	while (pos <= n && picolReMatch(re,s,n,pos,caps)) {
+		count++;
+		picolBufAppend(&b,&len,&z,s+pos,caps[0]-pos);
+		for (char *p = argv[j+2]; *p; p++) { /* & and \0-\9 are the match and its groups */
+			int g = -1;
+			if (*p == '&') g = 0;
+			else if (*p == '\\' && picolIsDigit(p[1])) g = *++p-'0';
+			else if (*p == '\\' && (p[1] == '\\' || p[1] == '&')) p++;
+			if (g < 0) picolBufAppend(&b,&len,&z,p,1);
+			else if (g <= re->nsub && caps[2*g] >= 0) picolBufAppend(&b,&len,&z,s+caps[2*g],caps[2*g+1]-caps[2*g]);
+		}
+		pos = caps[1];
+		if (caps[1] == caps[0]) { /* step over an empty match */
+			if (pos < n) picolBufAppend(&b,&len,&z,s+pos,1);
+			pos++;
+		}
+		if (!all) break;
+	}
+	if (pos < n) picolBufAppend(&b,&len,&z,s+pos,n-pos);
+	free(caps);
+	if (argc-j == 3) {
+		free(i->result);
+		i->result = b;
+		return PICOL_OK;
+	}
+	int retcode = picolSetVar(i,argv[j+3],b);
+	free(b);
+	if (retcode != PICOL_OK) return retcode;
+	picolSetIntResult(i,count);
+	return PICOL_OK;
+}
+
+static int picolCommandArray(struct picolInterp *i, int argc, char **argv, void *pd) {
+	if (argc != 3 && (argc != 4 || strcmp(argv[1],"set") != 0)) return picolArityErr(i,argv[0]);
+	struct picolVar *a = picolFindVar(i->callframe->vars,argv[2],strlen(argv[2]));
+	int n = 0, get = (strcmp(argv[1],"get") == 0);
+	char **w = NULL;
+	if (argc == 4) {
+		char **v = picolDictSplit(i,argv[3],&n);
+		if (n < 0) return PICOL_ERR;
+		int retcode = PICOL_OK;
+		for (int j = 0; j < n && retcode == PICOL_OK; j += 2) retcode = picolSetElem(i,argv[2],strlen(argv[2]),v[j],strlen(v[j]),v[j+1]);
+		picolFreeList(n,v);
+		if (retcode == PICOL_OK) picolSetResult(i,"");
+		return retcode;
+	}
+	if (!get && strcmp(argv[1],"names") != 0 && strcmp(argv[1],"size") != 0)
+		return picolErr(i,"Bad option '%s' for %s",argv[1],argv[0]);
+	for (int j = 0; a && a->elems && j < PICOL_ARRHASH; j++)
+		for (struct picolVar *e = a->elems[j]; e != NULL; e = e->next) {
+			w = realloc(w, sizeof(char*)*(n+2));
+			w[n++] = e->name;
+			if (get) w[n++] = e->val;
+		}
+	if (argv[1][0] == 's') picolSetIntResult(i,n);
+	else picolListResult(i,n,w);
+	free(w);
+	return PICOL_OK;
+}
+
+static int picolCommandLsort(struct picolInterp *i, int argc, char **argv, void *pd) {
+	struct picolSort ps = {i, PS_ASCII, 1, PICOL_OK, NULL};
+	int unique = 0, n, j;
+	for (j = 1; j < argc-1; j++)
+		if (strcmp(argv[j],"-ascii") == 0) ps.mode = PS_ASCII;
+		else if (strcmp(argv[j],"-dictionary") == 0) ps.mode = PS_DICTIONARY;
+		else if (strcmp(argv[j],"-integer") == 0) ps.mode = PS_INTEGER;
+		else if (strcmp(argv[j],"-real") == 0) ps.mode = PS_REAL;
+		else if (strcmp(argv[j],"-increasing") == 0) ps.order = 1;
+		else if (strcmp(argv[j],"-decreasing") == 0) ps.order = -1;
+		else if (strcmp(argv[j],"-unique") == 0) unique = 1;
+		else if (strcmp(argv[j],"-command") == 0 && j < argc-2) ps.mode = PS_COMMAND, ps.cmd = argv[++j];
+		else return picolErr(i,"Bad option '%s' for %s",argv[j],argv[0]);
+	if (j != argc-1) return picolArityErr(i,argv[0]);
+	char **v = picolSplitList(argv[j],&n), *e, *l = strdup("");
+	struct picolSortItem *items = malloc(sizeof(*items)*(n+n/2+1)); /* plus merge space */
+	for (j = 0; j < n; j++) {
+		items[j].s = v[j];
+		if (ps.mode != PS_INTEGER && ps.mode != PS_REAL) continue;
+		if (ps.mode == PS_INTEGER) items[j].ikey = strtol(v[j],&e,10);
+		else items[j].key = strtod(v[j],&e);
+		if (e == v[j] || *e) {
+			ps.retcode = picolErr(i,"Expected %s but got '%s'",(ps.mode == PS_INTEGER) ? "integer" : "real",v[j]);
+			break;
+		}
+	}
+	if (ps.retcode == PICOL_OK) picolMergeSort(&ps,items,items+n,n);
+	size_t len = 0;
+	for (j = 0; j < n && ps.retcode == PICOL_OK; j++) /* -unique keeps the last of a run of equals */
+		if (!unique || j == n-1 || picolSortCompare(&ps,&items[j],&items[j+1]) != 0)
+			l = picolListAppend(l,&len,items[j].s);
+	if (ps.retcode == PICOL_OK) free(i->result), i->result = l;
+	else free(l);
+	free(items);
+	picolFreeList(n,v);
+	return ps.retcode;
+}
+
+static void picolFreeInterp(struct picolInterp *i) {
+	while (i->callframe) picolDropCallFrame(i);
+	for (struct picolCallFrame *cf = i->spareframes, *t; cf != NULL; cf = t) t = cf->parent, free(cf);
+	for (int j = 0; j < PICOL_CMDHASH; j++)
+		for (struct picolCmd *c = i->commands[j], *t; c != NULL; c = t) {
+			t = c->next;
+			if (c->func == picolCommandCallProc) free(c->privdata); /* a single block */
+			free(c);
+		}
+	for (struct picolRegex *re = i->regexps, *t; re != NULL; re = t) t = re->next, picolReFree(re);
+	free(i->result);
+}
+
+static void picolRegisterCoreCommands(struct picolInterp *i) {
+	char *name[] = {"+","-","*","/",">",">=","<","<=","==","!="};
+	for (int j = 0; j < (int)(sizeof(name)/sizeof(char*)); j++)
+		picolRegisterCommand(i,name[j],picolCommandMath,NULL);
+	picolRegisterCommand(i,"set",picolCommandSet,NULL);
+	picolRegisterCommand(i,"incr",picolCommandIncr,NULL);
+	picolRegisterCommand(i,"append",picolCommandAppend,NULL);
+	picolRegisterCommand(i,"puts",picolCommandPuts,NULL);
+	picolRegisterCommand(i,"if",picolCommandIf,NULL);
+	picolRegisterCommand(i,"while",picolCommandWhile,NULL);
+	picolRegisterCommand(i,"foreach",picolCommandForeach,NULL);
+	picolRegisterCommand(i,"break",picolCommandRetCodes,NULL);
+	picolRegisterCommand(i,"continue",picolCommandRetCodes,NULL);
+	picolRegisterCommand(i,"proc",picolCommandProc,NULL);
+	picolRegisterCommand(i,"return",picolCommandReturn,NULL);
+	picolRegisterCommand(i,"catch",picolCommandCatch,NULL);
+	picolRegisterCommand(i,"limit",picolCommandLimit,NULL);
+	picolRegisterCommand(i,"list",picolCommandList,NULL);
+	picolRegisterCommand(i,"llength",picolCommandLlength,NULL);
+	picolRegisterCommand(i,"lindex",picolCommandLindex,NULL);
+	picolRegisterCommand(i,"lrange",picolCommandLrange,NULL);
+	picolRegisterCommand(i,"linsert",picolCommandLinsert,NULL);
+	picolRegisterCommand(i,"lappend",picolCommandLappend,NULL);
+	picolRegisterCommand(i,"lset",picolCommandLset,NULL);
+	picolRegisterCommand(i,"lsort",picolCommandLsort,NULL);
+	picolRegisterCommand(i,"dict",picolCommandDict,NULL);
+	picolRegisterCommand(i,"array",picolCommandArray,NULL);
+	picolRegisterCommand(i,"string",picolCommandString,NULL);
+	picolRegisterCommand(i,"regexp",picolCommandRegexp,NULL);
+	picolRegisterCommand(i,"regsub",picolCommandRegsub,NULL);
+}
+
+int main(int argc, char **argv) {
+	char *buf;
+	struct picolInterp interp;
+	picolInitInterp(&interp);
+	picolRegisterCoreCommands(&interp);
+	for (int retcode; argc == 1; free(buf)) {
+		printf("picol> "), fflush(stdout);
+		buf = picolGets(stdin,'\n');
+		if (buf == NULL || strcmp(buf,"quit") == 0) break;
+		retcode = picolEval(&interp,buf);
+		if (interp.result[0] != '\0') printf("[%d] %s\n", retcode, interp.result);
+	}
+	int status = EXIT_SUCCESS;
+	if (argc == 1) free(buf);
+	for (FILE *fp; argc > 1; argc--, argv++) {
+		if ((fp=fopen(argv[1],"r")) == NULL) { perror(argv[1]), status = EXIT_FAILURE; continue; }
+		buf = picolLoad(fp), fclose(fp);
+		int retcode = picolEval(&interp,buf);
+		if (retcode != PICOL_OK) puts(interp.result);
+		if (retcode == PICOL_ERR || retcode == PICOL_LIMIT) status = EXIT_FAILURE;
+		free(buf);
+	}
+	picolFreeInterp(&interp);
+	return status;
+}